@@ -1263,14 +1263,115 @@ static int alpha_int_svalue_cmpfun(const struct svalue *a, const struct svalue *
 #undef TYPE
 #undef ID
 
+/* Same, but only floats. */
+static int alpha_float_svalue_cmpfun(const struct svalue *a,
+				     const struct svalue *b)
+{
+#ifdef PIKE_DEBUG
+  if ((TYPEOF(*a) != T_FLOAT) || (TYPEOF(*b) != T_FLOAT)) {
+    Pike_fatal("Invalid elements in supposedly float array.\n");
+  }
+#endif /* PIKE_DEBUG */
+  if(a->u.float_number < b->u.float_number) return -1;
+  if(a->u.float_number > b->u.float_number) return  1;
+  return 0;
+}
+
+#define CMP(X,Y) alpha_float_svalue_cmpfun(X,Y)
+#define TYPE struct svalue
+#define ID low_sort_float_svalues
+#include "fsort_template.h"
+#undef CMP
+#undef TYPE
+#undef ID
+
+/* Same, but only strings. */
+#define CMP(X,Y) ((int)my_quick_strcmp((X)->u.string, (Y)->u.string))
+#define TYPE struct svalue
+#define ID low_sort_string_svalues
+#include "fsort_template.h"
+#undef CMP
+#undef TYPE
+#undef ID
+
+/* Arrays of integers at least this large are radix sorted. */
+#define RADIX_SORT_MIN_SIZE 1024
+
+/* Maps an integer to an unsigned key with the same order. */
+#define RADIX_INT_KEY(X) (((UINT64)(INT64)(X)) ^ (((UINT64)1) << 63))
+
+/* LSD radix sort of an array of integers, one byte per pass. Passes
+ * where all keys have the same byte are skipped, so small values
+ * only need a pass or two.
+ *
+ * Returns 0 if the temporary buffer could not be allocated.
+ */
+static int radix_sort_int_svalues(struct svalue *v, INT32 n)
+{
+  INT32 count[8][256];
+  struct svalue *tmp, *src = v, *dst;
+  INT32 i;
+  int pass;
+
+  if (!(tmp = malloc(n * sizeof(struct svalue)))) return 0;
+
+  memset(count, 0, sizeof(count));
+  for (i = 0; i < n; i++) {
+    UINT64 k = RADIX_INT_KEY(v[i].u.integer);
+    for (pass = 0; pass < 8; pass++)
+      count[pass][(k >> (pass * 8)) & 0xff]++;
+  }
+
+  dst = tmp;
+  for (pass = 0; pass < 8; pass++) {
+    INT32 *c = count[pass];
+    INT32 sum = 0;
+    int b;
+
+    if (c[(RADIX_INT_KEY(src->u.integer) >> (pass * 8)) & 0xff] == n)
+      continue;
+
+    for (b = 0; b < 256; b++) {
+      INT32 t = c[b];
+      c[b] = sum;
+      sum += t;
+    }
+    for (i = 0; i < n; i++) {
+      UINT64 k = RADIX_INT_KEY(src[i].u.integer);
+      dst[c[(k >> (pass * 8)) & 0xff]++] = src[i];
+    }
+    {
+      struct svalue *t = src;
+      src = dst;
+      dst = t;
+    }
+  }
+
+  if (src != v) memcpy(v, src, n * sizeof(struct svalue));
+  free(tmp);
+  return 1;
+}
+
 /** This sort is unstable. */
 PMOD_EXPORT void sort_array_destructively(struct array *v)
 {
   if(!v->size) return;
-  if (v->type_field == BIT_INT) {
+  switch (v->type_field) {
+  case BIT_INT:
+    if ((v->size >= RADIX_SORT_MIN_SIZE) &&
+	radix_sort_int_svalues(ITEM(v), v->size))
+      break;
     low_sort_int_svalues(ITEM(v), ITEM(v)+v->size-1);
-  } else {
+    break;
+  case BIT_FLOAT:
+    low_sort_float_svalues(ITEM(v), ITEM(v)+v->size-1);
+    break;
+  case BIT_STRING:
+    low_sort_string_svalues(ITEM(v), ITEM(v)+v->size-1);
+    break;
+  default:
     low_sort_svalues(ITEM(v), ITEM(v)+v->size-1);
+    break;
   }
 }
 
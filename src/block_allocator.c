@@ -12,12 +12,18 @@
 #include "block_allocator.h"
 #include "bitvector.h"
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #define BA_BLOCKN(l, p, n) ((struct ba_block_header *)((char*)(p) + (l).doffset + (n)*((l).block_size)))
 #define BA_LASTBLOCK(l, p) ((struct ba_block_header*)((char*)(p) + (l).doffset + (l).offset))
 #define BA_CHECK_PTR(l, p, ptr)	((size_t)((char*)(ptr) - (char*)(p)) <= (l).offset + (l).doffset)
 
 #define BA_ONE	((struct ba_block_header *)1)
 #define BA_FLAG_SORTED 1u
+#define BA_FLAG_IDLE	2u	/* Was empty at the last ba_release_empty_pages(). */
+#define BA_FLAG_RELEASED 4u	/* Memory has been returned to the OS. */
 
 #ifdef PIKE_DEBUG
 static void print_allocator(const struct block_allocator * a);
@@ -108,6 +114,99 @@ static struct ba_page * ba_alloc_page(struct block_allocator * a, int i) {
     return p;
 }
 
+/*
+ * Empty pages which are not the last one cannot be freed, since
+ * a->pages has to stay dense. Allocators with such pages are linked
+ * into ba_empty_list by ba_free(), and ba_release_empty_pages() later
+ * hands the memory of all blocks but the first back to the operating
+ * system for big pages which have stayed empty since the previous
+ * call. Their contents do not matter, since ba_alloc initializes the
+ * blocks following the first one lazily.
+ *
+ * The list is only touched with the interpreter lock held. Allocators
+ * that are used without it are initialized with BA_INIT_UNLOCKED, and
+ * are never linked into it.
+ */
+static struct block_allocator * ba_empty_list = NULL;
+
+static void ba_unlink_empty(struct block_allocator * a) {
+    struct block_allocator ** prev;
+
+    if (a->empty != BA_EMPTY_LISTED) return;
+
+    for (prev = &ba_empty_list; *prev; prev = &(*prev)->empty_next) {
+        if (*prev == a) {
+            *prev = a->empty_next;
+            break;
+        }
+    }
+    a->empty = BA_EMPTY_NONE;
+    a->empty_next = NULL;
+}
+
+#if defined(HAVE_MADVISE) && defined(MADV_DONTNEED)
+#define BA_RELEASE_THRESHOLD	(64 * 1024)
+
+static void ba_release_page(struct ba_page * p, const struct ba_layout * l) {
+    size_t psize = (size_t)page_size;
+    size_t start = (size_t)BA_BLOCKN(*l, p, 1);
+    size_t end = (size_t)BA_LASTBLOCK(*l, p) + l->block_size;
+
+    start = PIKE_ALIGNTO(start, psize);
+    end &= ~(psize - 1);
+
+    if (end > start && end - start >= BA_RELEASE_THRESHOLD) {
+        madvise((void*)start, end - start, MADV_DONTNEED);
+    }
+}
+#endif /* HAVE_MADVISE && MADV_DONTNEED */
+
+/*
+ * Called after each gc. Returns non-zero if a has pages which became
+ * empty since the previous call, and that thus have to be checked
+ * again next time.
+ */
+static int ba_release_allocator_pages(struct block_allocator * a) {
+    int i, pending = 0;
+    struct ba_layout l = a->l;
+
+    /* The last page is never empty, see ba_free_empty_pages(). */
+    for (i = 0; i < a->size - 1; i++, ba_double_layout(&l)) {
+        struct ba_page * p = a->pages[i];
+
+        if (p->h.used || (p->h.flags & BA_FLAG_RELEASED)) continue;
+
+        if (!(p->h.flags & BA_FLAG_IDLE)) {
+            p->h.flags |= BA_FLAG_IDLE;
+            pending = 1;
+            continue;
+        }
+
+#if defined(HAVE_MADVISE) && defined(MADV_DONTNEED)
+        ba_release_page(p, &l);
+#endif
+        p->h.flags |= BA_FLAG_RELEASED;
+    }
+
+    return pending;
+}
+
+PMOD_EXPORT void ba_release_empty_pages(void) {
+    struct block_allocator ** prev = &ba_empty_list;
+
+    while (*prev) {
+        struct block_allocator * a = *prev;
+
+        if (ba_release_allocator_pages(a)) {
+            prev = &a->empty_next;
+        } else {
+            *prev = a->empty_next;
+            a->empty = BA_EMPTY_NONE;
+            a->empty_next = NULL;
+        }
+    }
+}
+
 static void ba_free_empty_pages(struct block_allocator * a) {
     int i;
 
@@ -160,6 +259,8 @@ PMOD_EXPORT void ba_init_aligned(struct block_allocator * a, unsigned INT32 bloc
     a->l.alignment = alignment;
     ba_low_init_aligned(a);
     a->alloc = a->last_free = a->size = 0;
+    a->empty = BA_EMPTY_NONE;
+    a->empty_next = NULL;
     memset(a->pages, 0, sizeof(a->pages));
 }
 
@@ -168,6 +269,8 @@ PMOD_EXPORT void ba_destroy(struct block_allocator * a) {
 
     if (!a->l.offset) return;
 
+    ba_unlink_empty(a);
+
     for (i = 0; i < a->size; i++) {
 	if (a->pages[i]) {
 #ifdef DEBUG_MALLOC
@@ -188,6 +291,8 @@ PMOD_EXPORT void ba_free_all(struct block_allocator * a) {
     if (!a->l.offset) return;
     if (!a->size) return;
 
+    ba_unlink_empty(a);
+
     for (i = 0; i < a->size; i++) {
         free(a->pages[i]);
         a->pages[i] = NULL;
@@ -339,6 +444,11 @@ found:
                 ba_free_empty_pages(a);
             } else {
                 ba_clear_page(a, p, &l);
+                if (a->empty == BA_EMPTY_NONE) {
+                    a->empty = BA_EMPTY_LISTED;
+                    a->empty_next = ba_empty_list;
+                    ba_empty_list = a;
+                }
             }
 	}
     } else {
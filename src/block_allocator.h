@@ -33,7 +33,7 @@ struct ba_page {
 
 struct block_allocator {
     struct ba_layout l;
-    unsigned char size, last_free, alloc;
+    unsigned char size, last_free, alloc, empty;
     /*
      * This places an upper limit on the number of blocks
      * and should be adjusted as needed.
@@ -44,8 +44,15 @@ struct block_allocator {
      * 192 GB of short pike strings with shift width 0 can be allocated.
      */
     struct ba_page * pages[24];
+    /* Next allocator with empty pages, see ba_release_empty_pages(). */
+    struct block_allocator * empty_next;
 };
 
+/* Values of block_allocator.empty. */
+#define BA_EMPTY_NONE		0
+#define BA_EMPTY_LISTED		1	/* Linked into the empty list. */
+#define BA_EMPTY_UNLOCKED	2	/* Never linked, see BA_INIT_UNLOCKED. */
+
 struct ba_iterator {
     void * cur;
     void * end;
@@ -67,18 +74,28 @@ static inline void PIKE_UNUSED_ATTRIBUTE * ba_it_val(struct ba_iterator * it) {
     return it->cur;
 }
 
-#define BA_INIT_ALIGNED(block_size, blocks, alignment) {    \
+#define BA_LOW_INIT(block_size, blocks, alignment, empty) {   \
     BA_LAYOUT_INIT(block_size, blocks, alignment),	    \
-    0, 0, 0,						    \
+    0, 0, 0, empty,					    \
     { NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,		    \
       NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL,		    \
-      NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL }		    \
+      NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL },	    \
+    NULL						    \
 }
 
+#define BA_INIT_ALIGNED(block_size, blocks, alignment)	    \
+    BA_LOW_INIT(block_size, blocks, alignment, BA_EMPTY_NONE)
+
 #define BA_INIT(block_size, blocks) BA_INIT_ALIGNED(block_size, blocks, 0)
 
 #define BA_INIT_PAGES(block_size, pages)	BA_INIT(block_size, ((pages) * PIKE_MALLOC_PAGE_SIZE)/(block_size))
 
+/* For allocators that are used without holding the interpreter lock.
+ * ba_release_empty_pages() never touches their pages. */
+#define BA_INIT_UNLOCKED(block_size, pages)		    \
+    BA_LOW_INIT(block_size, ((pages) * PIKE_MALLOC_PAGE_SIZE)/(block_size), \
+		0, BA_EMPTY_UNLOCKED)
+
 PMOD_EXPORT void ba_init_aligned(struct block_allocator * a, unsigned INT32 block_size, unsigned INT32 blocks,
 				 unsigned INT32 alignment);
 ATTRIBUTE((malloc)) PMOD_EXPORT void * ba_alloc(struct block_allocator * a);
@@ -87,6 +104,7 @@ PMOD_EXPORT void ba_destroy(struct block_allocator * a);
 PMOD_EXPORT void ba_free_all(struct block_allocator * a);
 PMOD_EXPORT size_t ba_count(const struct block_allocator * a);
 PMOD_EXPORT void ba_count_all(const struct block_allocator * a, size_t * num, size_t * size);
+PMOD_EXPORT void ba_release_empty_pages(void);
 
 static inline void PIKE_UNUSED_ATTRIBUTE ba_init(struct block_allocator * a, unsigned INT32 block_size, unsigned INT32 blocks) {
     ba_init_aligned(a, block_size, blocks, 0);
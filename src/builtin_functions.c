@@ -60,6 +60,12 @@
 #include <crypt.h>
 #endif
 
+/* Strings larger than this (in bytes) are processed with the
+ * interpreter lock released, so that other threads may run
+ * concurrently while we work on the (immutable) string data.
+ */
+#define STRING_THREADS_ALLOW_THRESHOLD	(512 * 1024)
+
 /* #define DIFF_DEBUG */
 /* #define ENABLE_DYN_DIFF */
 
@@ -464,11 +470,20 @@ static void f_hash_8_0(INT32 args)
 PMOD_EXPORT void f_hash( INT32 args )
 {
   size_t res;
+  struct pike_string *s;
 
   if( TYPEOF(Pike_sp[-args]) != PIKE_T_STRING )
       PIKE_ERROR("hash","Argument is not a string\n",Pike_sp,args);
 
-  res = pike_string_siphash24(Pike_sp[-args].u.string, 0) & 0x7fffffff;
+  s = Pike_sp[-args].u.string;
+  if ((s->len << s->size_shift) >= STRING_THREADS_ALLOW_THRESHOLD) {
+    /* Large string. Release the interpreter lock while hashing. */
+    THREADS_ALLOW();
+    res = pike_string_siphash24(s, 0) & 0x7fffffff;
+    THREADS_DISALLOW();
+  } else {
+    res = pike_string_siphash24(s, 0) & 0x7fffffff;
+  }
 
   if( args > 1 ) {
     if(TYPEOF(Pike_sp[1-args]) != T_INT)
@@ -2247,6 +2262,87 @@ static void f_string_filter_non_unicode( INT32 args )
   }
 }
 
+/* Encode the string in as UTF-8 into dst, which must have room
+ * for the encoded string. Returns a pointer to the end of the
+ * encoded data.
+ *
+ * NB: Does not perform any range checks (that is left to the
+ *     caller), and does not touch any interpreter state, so it
+ *     may be called with the interpreter lock released.
+ */
+static unsigned char *low_string_to_utf8(unsigned char *dst,
+					 struct pike_string *in,
+					 INT_TYPE extended)
+{
+  ptrdiff_t i;
+  PCHARP src;
+
+  for(i=0,src=MKPCHARP_STR(in); i < in->len; INC_PCHARP(src,1),i++) {
+    unsigned INT32 c = EXTRACT_PCHARP(src);
+    if (!(c & ~0x7f)) {
+      /* 7bit */
+      *dst++ = c;
+    } else if (!(c & ~0x7ff)) {
+      /* 11bit */
+      *dst++ = 0xc0 | (c >> 6);
+      *dst++ = 0x80 | (c & 0x3f);
+    } else if (!(c & ~0xffff)) {
+      /* 16bit */
+      *dst++ = 0xe0 | (c >> 12);
+      *dst++ = 0x80 | ((c >> 6) & 0x3f);
+      *dst++ = 0x80 | (c & 0x3f);
+    } else if ((extended & 2) && (c <= 0x10ffff)) {
+      /* Encode with surrogates. */
+      c -= 0x10000;
+      /* 0xd800 | (c>>10)
+       * 0b1101 10cccc cccccc
+       * UTF8: 11101101 1010cccc 10cccccc
+       */
+      *dst++ = 0xed;
+      *dst++ = 0xa0 | (c >> 16);
+      *dst++ = 0x80 | ((c >> 10) & 0x3f);
+      /* 0xdc00 | (c & 0x3ff)
+       * 0b1101 11cccc cccccc
+       * UTF8: 11101101 1011cccc 10cccccc
+       */
+      *dst++ = 0xed;
+      *dst++ = 0xb0 | ((c >> 6) & 0x3f);
+      *dst++ = 0x80 | (c & 0x3f);
+    } else if (!(c & ~0x1fffff)) {
+      /* 21bit */
+      *dst++ = 0xf0 | (c >> 18);
+      *dst++ = 0x80 | ((c >> 12) & 0x3f);
+      *dst++ = 0x80 | ((c >> 6) & 0x3f);
+      *dst++ = 0x80 | (c & 0x3f);
+    } else if (!(c & ~0x3ffffff)) {
+      /* 26bit */
+      *dst++ = 0xf8 | (c >> 24);
+      *dst++ = 0x80 | ((c >> 18) & 0x3f);
+      *dst++ = 0x80 | ((c >> 12) & 0x3f);
+      *dst++ = 0x80 | ((c >> 6) & 0x3f);
+      *dst++ = 0x80 | (c & 0x3f);
+    } else if (!(c & ~0x7fffffff)) {
+      /* 31bit */
+      *dst++ = 0xfc | (c >> 30);
+      *dst++ = 0x80 | ((c >> 24) & 0x3f);
+      *dst++ = 0x80 | ((c >> 18) & 0x3f);
+      *dst++ = 0x80 | ((c >> 12) & 0x3f);
+      *dst++ = 0x80 | ((c >> 6) & 0x3f);
+      *dst++ = 0x80 | (c & 0x3f);
+    } else {
+      /* 32 - 36bit */
+      *dst++ = (char)0xfe;
+      *dst++ = 0x80 | ((c >> 30) & 0x3f);
+      *dst++ = 0x80 | ((c >> 24) & 0x3f);
+      *dst++ = 0x80 | ((c >> 18) & 0x3f);
+      *dst++ = 0x80 | ((c >> 12) & 0x3f);
+      *dst++ = 0x80 | ((c >> 6) & 0x3f);
+      *dst++ = 0x80 | (c & 0x3f);
+    }
+  }
+  return dst;
+}
+
 /*! @decl utf8_string string_to_utf8(string s)
  *! @decl utf8_string string_to_utf8(string s, int extended)
  *!
@@ -2285,7 +2381,8 @@ PMOD_EXPORT void f_string_to_utf8(INT32 args)
   INT_TYPE extended = 0;
   PCHARP src;
   INT32 min, max;
-  unsigned char * dst;
+  /* Only checked with PIKE_DEBUG. */
+  unsigned char * dst PIKE_UNUSED_ATTRIBUTE;
 
   get_all_args("string_to_utf8", args, "%W.%i", &in, &extended);
 
@@ -2348,70 +2445,13 @@ PMOD_EXPORT void f_string_to_utf8(INT32 args)
     return;
   }
   out = begin_shared_string(len);
-  dst = STR0(out);
-
-  for(i=0,src=MKPCHARP_STR(in); i < in->len; INC_PCHARP(src,1),i++) {
-    unsigned INT32 c = EXTRACT_PCHARP(src);
-    if (!(c & ~0x7f)) {
-      /* 7bit */
-      *dst++ = c;
-    } else if (!(c & ~0x7ff)) {
-      /* 11bit */
-      *dst++ = 0xc0 | (c >> 6);
-      *dst++ = 0x80 | (c & 0x3f);
-    } else if (!(c & ~0xffff)) {
-      /* 16bit */
-      *dst++ = 0xe0 | (c >> 12);
-      *dst++ = 0x80 | ((c >> 6) & 0x3f);
-      *dst++ = 0x80 | (c & 0x3f);
-    } else if ((extended & 2) && (c <= 0x10ffff)) {
-      /* Encode with surrogates. */
-      c -= 0x10000;
-      /* 0xd800 | (c>>10)
-       * 0b1101 10cccc cccccc
-       * UTF8: 11101101 1010cccc 10cccccc
-       */
-      *dst++ = 0xed;
-      *dst++ = 0xa0 | (c >> 16);
-      *dst++ = 0x80 | ((c >> 10) & 0x3f);
-      /* 0xdc00 | (c & 0x3ff)
-       * 0b1101 11cccc cccccc
-       * UTF8: 11101101 1011cccc 10cccccc
-       */
-      *dst++ = 0xed;
-      *dst++ = 0xb0 | ((c >> 6) & 0x3f);
-      *dst++ = 0x80 | (c & 0x3f);
-    } else if (!(c & ~0x1fffff)) {
-      /* 21bit */
-      *dst++ = 0xf0 | (c >> 18);
-      *dst++ = 0x80 | ((c >> 12) & 0x3f);
-      *dst++ = 0x80 | ((c >> 6) & 0x3f);
-      *dst++ = 0x80 | (c & 0x3f);
-    } else if (!(c & ~0x3ffffff)) {
-      /* 26bit */
-      *dst++ = 0xf8 | (c >> 24);
-      *dst++ = 0x80 | ((c >> 18) & 0x3f);
-      *dst++ = 0x80 | ((c >> 12) & 0x3f);
-      *dst++ = 0x80 | ((c >> 6) & 0x3f);
-      *dst++ = 0x80 | (c & 0x3f);
-    } else if (!(c & ~0x7fffffff)) {
-      /* 31bit */
-      *dst++ = 0xfc | (c >> 30);
-      *dst++ = 0x80 | ((c >> 24) & 0x3f);
-      *dst++ = 0x80 | ((c >> 18) & 0x3f);
-      *dst++ = 0x80 | ((c >> 12) & 0x3f);
-      *dst++ = 0x80 | ((c >> 6) & 0x3f);
-      *dst++ = 0x80 | (c & 0x3f);
-    } else {
-      /* 32 - 36bit */
-      *dst++ = (char)0xfe;
-      *dst++ = 0x80 | ((c >> 30) & 0x3f);
-      *dst++ = 0x80 | ((c >> 24) & 0x3f);
-      *dst++ = 0x80 | ((c >> 18) & 0x3f);
-      *dst++ = 0x80 | ((c >> 12) & 0x3f);
-      *dst++ = 0x80 | ((c >> 6) & 0x3f);
-      *dst++ = 0x80 | (c & 0x3f);
-    }
+  if (len >= STRING_THREADS_ALLOW_THRESHOLD) {
+    /* Large string. Release the interpreter lock while encoding. */
+    THREADS_ALLOW();
+    dst = low_string_to_utf8(STR0(out), in, extended);
+    THREADS_DISALLOW();
+  } else {
+    dst = low_string_to_utf8(STR0(out), in, extended);
   }
 #ifdef PIKE_DEBUG
   if (len != dst - STR0(out)) {
@@ -4460,8 +4500,8 @@ PMOD_EXPORT void f_reverse(INT32 args)
       end++;
     }
     s=begin_wide_shared_string(orig->len, orig->size_shift);
-    if ((orig->len << orig->size_shift) >= 524288) {
-      /* More than 512KB. Release the interpreter lock. */
+    if ((orig->len << orig->size_shift) >= STRING_THREADS_ALLOW_THRESHOLD) {
+      /* Large string. Release the interpreter lock. */
       THREADS_ALLOW();
       switch(orig->size_shift)
       {
@@ -4656,12 +4696,116 @@ int find_longest_prefix(char *str,
 }
 
 
+/* Returns the index in v for the longest replacement string in the
+ * trie that is a prefix of str, or -1 if none.
+ */
+static INT32 find_longest_trie_prefix(const struct replace_many_trie_node *trie,
+				      PCHARP str,
+				      ptrdiff_t len)
+{
+  INT32 node = 0, match = -1;
+  ptrdiff_t pos;
+
+  for (pos = 0; pos < len; pos++) {
+    p_wchar2 ch = INDEX_PCHARP(str, pos);
+    INT32 a = trie[node].first_child;
+    INT32 end = a + trie[node].num_children;
+    INT32 b = end;
+
+    while (a < b) {
+      INT32 c = a + (b - a)/2;
+      if (trie[c].ch < ch) a = c + 1;
+      else b = c;
+    }
+    if ((a == end) || (trie[a].ch != ch)) break;
+    node = a;
+    if (trie[node].match >= 0) match = trie[node].match;
+  }
+  return match;
+}
+
 static int replace_sortfun(struct replace_many_tupel *a,
 			   struct replace_many_tupel *b)
 {
   return (int)my_quick_strcmp(a->ind, b->ind);
 }
 
+/* Number of replace strings at which execute_replace_many() switches
+ * from binary search to walking a trie. The trie makes the cost per
+ * position depend on the length of the match rather than on the
+ * number of replace strings.
+ */
+#define REPLACE_TRIE_MIN_SIZE	64
+
+/* Build the trie from the sorted ctx->v. The nodes are allocated in
+ * breadth first order, which means that the children of a node end
+ * up consecutive and sorted.
+ *
+ * On failure ctx->trie is left as NULL, and the binary search is
+ * used instead.
+ */
+static void build_replace_many_trie(struct replace_many_context *ctx)
+{
+  struct replace_many_trie_node *trie;
+  INT32 *range;
+  INT32 e, n, cnt;
+  size_t max_nodes = 1;
+
+  for (e = 0; e < ctx->num; e++) {
+    max_nodes += ctx->v[e].ind->len;
+    if (max_nodes > (size_t)(INT32_MAX/3)) return;
+  }
+
+  trie = malloc(sizeof(struct replace_many_trie_node) * max_nodes);
+  /* Start, end and depth for each node. */
+  range = malloc(sizeof(INT32) * 3 * max_nodes);
+  if (!trie || !range) {
+    free(trie);
+    free(range);
+    return;
+  }
+
+  trie[0].ch = 0;
+  range[0] = 0;
+  range[1] = ctx->num;
+  range[2] = 0;
+  cnt = 1;
+
+  for (n = 0; n < cnt; n++) {
+    INT32 a = range[n*3];
+    INT32 b = range[n*3 + 1];
+    INT32 depth = range[n*3 + 2];
+
+    /* Strings that end here sort before the longer ones. */
+    trie[n].match = -1;
+    while ((a < b) && (ctx->v[a].ind->len == depth)) {
+      if (trie[n].match < 0) trie[n].match = a;
+      a++;
+    }
+
+    trie[n].first_child = cnt;
+    while (a < b) {
+      p_wchar2 ch = index_shared_string(ctx->v[a].ind, depth);
+      e = a + 1;
+      while ((e < b) && (index_shared_string(ctx->v[e].ind, depth) == ch))
+	e++;
+      trie[cnt].ch = ch;
+      range[cnt*3] = a;
+      range[cnt*3 + 1] = e;
+      range[cnt*3 + 2] = depth + 1;
+      cnt++;
+      a = e;
+    }
+    trie[n].num_children = cnt - trie[n].first_child;
+  }
+
+  free(range);
+
+  ctx->trie = realloc(trie, sizeof(struct replace_many_trie_node) * cnt);
+  if (!ctx->trie) ctx->trie = trie;
+  ctx->trie_size = cnt;
+}
+
 void free_replace_many_context(struct replace_many_context *ctx)
 {
   if (ctx->v) {
@@ -4679,6 +4823,11 @@ void free_replace_many_context(struct replace_many_context *ctx)
     free (ctx->v);
     ctx->v = NULL;
   }
+  if (ctx->trie) {
+    free(ctx->trie);
+    ctx->trie = NULL;
+    ctx->trie_size = 0;
+  }
 }
 
 void compile_replace_many(struct replace_many_context *ctx,
@@ -4689,6 +4838,8 @@ void compile_replace_many(struct replace_many_context *ctx,
   INT32 e, num;
 
   ctx->v = NULL;
+  ctx->trie = NULL;
+  ctx->trie_size = 0;
   ctx->empty_repl = NULL;
 
 #if INT32_MAX >= LONG_MAX
@@ -4792,6 +4943,9 @@ void compile_replace_many(struct replace_many_context *ctx,
     }
   }
   ctx->num = num;
+
+  if (num >= REPLACE_TRIE_MIN_SIZE)
+    build_replace_many_trie(ctx);
 }
 
 struct pike_string *execute_replace_many(struct replace_many_context *ctx,
@@ -4803,8 +4957,6 @@ struct pike_string *execute_replace_many(struct replace_many_context *ctx,
   init_string_builder(&ret, str->size_shift);
   SET_ONERROR(uwp, free_string_builder, &ret);
 
-  /* FIXME: We really ought to build a trie! */
-
   switch (str->size_shift) {
 #define CASE(SZ)					\
     case (SZ):						\
@@ -4830,10 +4982,15 @@ struct pike_string *execute_replace_many(struct replace_many_context *ctx,
 	  if (a >= b)					\
 	    goto PIKE_CONCAT(next_char, SZ);		\
 							\
-	  a = find_longest_prefix((char *)(ss + s),	\
-				  length,		\
-				  SZ,			\
-				  ctx->v, a, b);	\
+	  if (ctx->trie)				\
+	    a = find_longest_trie_prefix(ctx->trie,	\
+					 MKPCHARP(ss + s, SZ),	\
+					 length);	\
+	  else						\
+	    a = find_longest_prefix((char *)(ss + s),	\
+				    length,		\
+				    SZ,			\
+				    ctx->v, a, b);	\
 							\
 	  if(a >= 0)					\
 	  {						\
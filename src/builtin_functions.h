@@ -35,9 +35,23 @@ struct replace_many_tupel
   struct pike_string *val;
 };
 
+/* Node in the prefix trie used by execute_replace_many() for large
+ * sets of replace strings. The children of a node are stored
+ * consecutively, sorted on ch.
+ */
+struct replace_many_trie_node
+{
+  p_wchar2 ch;
+  INT32 match;		/* Index in v, or -1. */
+  INT32 first_child;
+  INT32 num_children;
+};
+
 struct replace_many_context
 {
   struct replace_many_tupel *v;
+  struct replace_many_trie_node *trie;
+  INT32 trie_size;
   struct pike_string *empty_repl;
   int set_start[256];
   int set_end[256];
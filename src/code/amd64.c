@@ -2291,6 +2291,10 @@ void ins_f_byte(unsigned int b)
   LABEL_C;
     }
     return;
+  case F_ADD:
+    /* Generic addition is most often int+int in loops where the
+       compiler could not prove the types, so guard for that case
+       inline and fall back to f_add for everything else. */
   case F_ADD_INTS:
     {
       ins_debug_instr_prologue(b, 0, 0);
@@ -2641,15 +2645,6 @@ void ins_f_byte(unsigned int b)
       LABEL_D;
     }
     return;
-  case F_ADD:
-    {
-    addr = f_add;
-    update_arg1(2);
-    amd64_call_c_opcode(addr, flags);
-    amd64_load_sp_reg();
-    }
-    return;
-
   case F_SUBTRACT:
     {
     LABELS();
@@ -194,6 +194,30 @@ static cpu_time_t last_gc_end_real_time = -1;
 cpu_time_t auto_gc_time = 0;
 cpu_time_t auto_gc_real_time = 0;
 
+/* Pause time statistics. Bucket 0 in gc_pause_histogram counts the
+ * runs that took less than 1 ms real time, and bucket n > 0 those
+ * that took between 2^(n-1) and 2^n ms. The last bucket also counts
+ * everything longer than that. */
+#define GC_PAUSE_HISTOGRAM_SIZE	16
+static cpu_time_t last_gc_pause = 0;
+static cpu_time_t max_gc_pause = 0;
+static unsigned INT32 gc_pause_histogram[GC_PAUSE_HISTOGRAM_SIZE];
+
+static void record_gc_pause(cpu_time_t pause)
+{
+  cpu_time_t ms = pause / (CPU_TIME_TICKS / 1000);
+  int bucket = 0;
+
+  last_gc_pause = pause;
+  if (pause > max_gc_pause) max_gc_pause = pause;
+
+  while (ms && (bucket < GC_PAUSE_HISTOGRAM_SIZE - 1)) {
+    ms >>= 1;
+    bucket++;
+  }
+  gc_pause_histogram[bucket]++;
+}
+
 struct link_frame		/* See cycle checking blurb below. */
 {
   void *data;
@@ -3915,6 +3939,7 @@ size_t do_gc(int explicit_call)
     if (last_gc_end_real_time > gc_start_real_time) {
       gc_time = gc_time * multiplier +
 	(last_gc_end_real_time - gc_start_real_time) * (1.0 - multiplier);
+      record_gc_pause(last_gc_end_real_time - gc_start_real_time);
     }
 
 #ifdef GC_INTERVAL_DEBUG
@@ -4084,6 +4109,10 @@ size_t do_gc(int explicit_call)
   Pike_in_gc=0;
   exit_gc();
 
+  /* Return memory of block allocator pages that have stayed empty
+   * since the previous gc to the OS. */
+  ba_release_empty_pages();
+
 #ifdef ALWAYS_GC
   ADD_GC_CALLBACK();
 #else
@@ -4110,7 +4139,7 @@ void do_gc_callback(struct callback *UNUSED(cb), void *UNUSED(arg1),
     do_gc(0);
 }
 
-/*! @decl mapping(string:int|float) gc_status()
+/*! @decl mapping(string:int|float|string|array(int)) gc_status()
  *! @belongs Debug
  *!
  *! Get statistics from the garbage collector.
@@ -4158,6 +4187,18 @@ void do_gc_callback(struct callback *UNUSED(cb), void *UNUSED(arg1),
  *!     @member int "total_gc_real_time"
  *!       The total amount of real time that has been spent in
  *!       implicit GC runs, in nanoseconds.
+ *!     @member int "last_gc_pause"
+ *!       The length of the last gc run (implicit or explicit),
+ *!       measured in real time nanoseconds.
+ *!     @member int "max_gc_pause"
+ *!       The length of the longest gc run so far, measured in real
+ *!       time nanoseconds.
+ *!     @member array(int) "gc_pause_histogram"
+ *!       Histogram over the lengths of all gc runs so far. Element
+ *!       @expr{0@} is the number of runs that took less than 1 ms,
+ *!       and element @expr{n@} the number of runs that took at least
+ *!       @expr{1<<(n-1)@} ms but less than @expr{1<<n@} ms. The last
+ *!       element also counts all runs that took longer than that.
  *!   @endmapping
  *!
  *! @seealso
@@ -4166,6 +4207,7 @@ void do_gc_callback(struct callback *UNUSED(cb), void *UNUSED(arg1),
 void f__gc_status(INT32 args)
 {
   int size = 0;
+  int i;
 
   pop_n_elems(args);
 
@@ -4241,6 +4283,28 @@ void f__gc_status(INT32 args)
 #endif
   size++;
 
+  push_static_text ("last_gc_pause");
+  push_int64 (last_gc_pause);
+#ifndef LONG_CPU_TIME
+  push_int (1000000000 / CPU_TIME_TICKS);
+  o_multiply();
+#endif
+  size++;
+
+  push_static_text ("max_gc_pause");
+  push_int64 (max_gc_pause);
+#ifndef LONG_CPU_TIME
+  push_int (1000000000 / CPU_TIME_TICKS);
+  o_multiply();
+#endif
+  size++;
+
+  push_static_text ("gc_pause_histogram");
+  for (i = 0; i < GC_PAUSE_HISTOGRAM_SIZE; i++)
+    push_int64 (gc_pause_histogram[i]);
+  f_aggregate (GC_PAUSE_HISTOGRAM_SIZE);
+  size++;
+
 #ifdef PIKE_DEBUG
   push_static_text ("max_rec_frames");
   push_int64 ((INT64) tot_max_rec_frames);
@@ -2078,9 +2078,30 @@ OPCODE2(F_LOCAL_ARROW, "local->x", I_UPDATE_SP, {
 OPCODE1(F_ARROW, "->x", 0, {
   struct svalue tmp;
   struct svalue tmp2;
-  SET_SVAL(tmp, PIKE_T_STRING, 1, string,
-	   Pike_fp->context->prog->strings[arg1]);
-  index_no_free(&tmp2, Pike_sp-1, &tmp);
+  struct object *o;
+  struct program *p;
+
+  if ((TYPEOF(Pike_sp[-1]) == T_OBJECT) &&
+      (p = (o = Pike_sp[-1].u.object)->prog) &&
+      ((p = p->inherits[SUBTYPEOF(Pike_sp[-1])].prog)->flags &
+       PROGRAM_FIXED) &&
+      (QUICK_FIND_LFUN(p, LFUN_ARROW) == -1)) {
+    /* Common case: Plain object without `->(). Look up the identifier
+     * via the find_function cache just like F_CALL_OTHER does.
+     */
+    int fun = find_shared_string_identifier(Pike_fp->context->prog->strings[arg1],
+					    p);
+    if (fun >= 0) {
+      fun += o->prog->inherits[SUBTYPEOF(Pike_sp[-1])].identifier_level;
+      low_object_index_no_free(&tmp2, o, fun);
+    } else {
+      SET_SVAL(tmp2, T_INT, NUMBER_UNDEFINED, integer, 0);
+    }
+  } else {
+    SET_SVAL(tmp, PIKE_T_STRING, 1, string,
+	     Pike_fp->context->prog->strings[arg1]);
+    index_no_free(&tmp2, Pike_sp-1, &tmp);
+  }
   free_svalue(Pike_sp-1);
   move_svalue (Pike_sp - 1, &tmp2);
   print_return_value();
@@ -1384,6 +1384,31 @@ PMOD_EXPORT struct svalue *low_mapping_lookup(struct mapping *m,
 #ifdef PIKE_DEBUG
   if(d_flag > 1) check_mapping_type_fields(m);
 #endif
+
+  md = m->data;
+  if (((TYPEOF(*key) == T_STRING) || (TYPEOF(*key) == T_INT)) &&
+      !(md->ind_types & BIT_OBJECT)) {
+    /* Fast path for the common case of string or integer keys.
+     *
+     * As long as there are no objects among the indices, is_eq()
+     * for these types is the same as is_identical(), and can't call
+     * any Pike code. That means that the mapping data can't change
+     * under our feet, so we don't need to lock it, and we can
+     * compare the values inline.
+     */
+    if (!md->hashsize || !check_type_contains(md->ind_types, key))
+      return 0;
+    for (k = md->hash[h2 & (md->hashsize - 1)]; k; k = k->next) {
+      if ((h2 == k->hval) && (TYPEOF(k->ind) == TYPEOF(*key)) &&
+	  ((TYPEOF(*key) == T_STRING)?
+	   (k->ind.u.string == key->u.string):
+	   (k->ind.u.integer == key->u.integer))) {
+	return &k->val;
+      }
+    }
+    return 0;
+  }
+
   FIND();
   if(k)
   {
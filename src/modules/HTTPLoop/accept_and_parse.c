@@ -649,6 +649,9 @@ static void f_accept_with_http_parse(INT32 nargs)
  *!   The number of misses since start
  *! @member int stale
  *!   The number of misses that were stale hits, and not used
+ *! @member int evicted
+ *!   The number of entries that have been removed to keep the
+ *!   cache below @expr{max_size@}
  *! @member int size
  *!   The total current size
  *! @member int entries
@@ -676,6 +679,8 @@ static void f_cache_status(INT32 args)
   push_int64(c->misses);
   push_static_text("stale");
   push_int64(c->stale);
+  push_static_text("evicted");
+  push_int64(c->evicted);
   push_static_text("size");
   push_int64(c->size);
   push_static_text("entries");
@@ -690,7 +695,7 @@ static void f_cache_status(INT32 args)
   push_int(c->num_requests);    c->num_requests=0;
   push_static_text("received_bytes");
   push_int(c->received_data);c->received_data=0;
-  f_aggregate_mapping( 18 );
+  f_aggregate_mapping( 20 );
 }
 /*! @endclass
  */
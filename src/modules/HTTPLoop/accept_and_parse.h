@@ -80,7 +80,7 @@ struct cache
   struct cache *next;
   struct cache_entry *htable[CACHE_HTABLE_SIZE];
   UINT64 size, entries, max_size;
-  UINT64 hits, misses, stale;
+  UINT64 hits, misses, stale, evicted;
   size_t num_requests, sent_data, received_data;
   int gone;
 };
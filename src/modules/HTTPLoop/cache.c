@@ -262,6 +262,8 @@ struct cache_entry *aap_cache_lookup(char *s, ptrdiff_t len,
       int t = aap_get_time();
       if(e->stale_at < t)
       {
+        c->stale++;
+        c->misses++;
         aap_free_cache_entry( c, e, prev, h );
 	if(!nolock) mt_unlock(&c->mutex);
 	return 0;
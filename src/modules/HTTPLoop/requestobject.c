@@ -855,7 +855,11 @@ void f_aap_reply_with_cache(INT32 args)
 	    pp = p;
 	    p = p->next;
 	  }
-	  if(pp) aap_free_cache_entry(rc,pp,ppp,i);
+	  if(pp)
+	  {
+	    aap_free_cache_entry(rc,pp,ppp,i);
+	    rc->evicted++;
+	  }
 	  freed++;
 	  if((size_t)rc->size < (size_t)target)
 	    break;
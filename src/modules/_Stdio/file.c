@@ -1813,7 +1813,7 @@ static void file__disable_callbacks(INT32 UNUSED(args))
 
 /*! @decl int write(string data)
  *! @decl int write(string format, mixed ... extras)
- *! @decl int write(array(string) data)
+ *! @decl int write(array(string|Stdio.Buffer|String.Buffer|System.Memory) data)
  *! @decl int write(array(string) format, mixed ... extras)
  *! @decl int write(Stdio.Buffer|String.Buffer|System.Memory data, void|int(0..) offset)
  *!
@@ -1826,6 +1826,9 @@ static void file__disable_callbacks(INT32 UNUSED(args))
  *!   Data to write.
  *!
  *!   If @[data] is an array of strings, they are written in sequence.
+ *!   The array may also contain buffer objects, in which case their
+ *!   contents are written in place without first joining everything
+ *!   into a single string.
  *!
  *! @param format
  *! @param extras
@@ -1883,49 +1886,88 @@ static void file__disable_callbacks(INT32 UNUSED(args))
  *!   charsets supported by @[Charset.encoder].
  *!
  *! @note
- *!   The variant of this function using a buffer object does not release
+ *!   The variants of this function using buffer objects do not release
  *!   the interpreter lock.
  *!
  *! @seealso
  *!   @[read()], @[write_oob()], @[send_fd()]
  */
 #ifdef HAVE_WRITEV
-static ptrdiff_t file_write_array(struct my_file *file, struct array *a)
+/* Fills in iov (which has room for max entries) with the strings and
+ * buffer objects in a, skipping the first skip bytes. Returns the
+ * number of entries used. Clears *threads_allowed if a contains any
+ * buffer objects.
+ */
+static int file_fill_iovec(struct array *a, struct iovec *iov, int max,
+                           ptrdiff_t skip, int *threads_allowed)
 {
-  ptrdiff_t written, i;
-  struct iovec *iovbase = xalloc(sizeof(struct iovec)*a->size);
-  struct iovec *iov = iovbase;
-  int iovcnt = a->size;
-  int e = 0;
-
-  i = a->size;
-  while(i--) {
-    struct pike_string *s = a->item[i].u.string;
+  ptrdiff_t i;
+  int iovcnt = 0;
+
+  for (i = 0; (i < a->size) && (iovcnt < max); i++) {
+    void *ptr;
+    size_t len;
+    int shift;
+
+    if (TYPEOF(a->item[i]) == PIKE_T_STRING) {
+      struct pike_string *s = a->item[i].u.string;
+      ptr = s->str;
+      len = s->len;
+      shift = s->size_shift;
+    } else if ((TYPEOF(a->item[i]) == PIKE_T_OBJECT) &&
+               (get_memory_object_memory(a->item[i].u.object, &ptr, &len,
+                                         &shift) != MEMOBJ_NONE)) {
+      *threads_allowed = 0;
+    } else {
+      free(iov);
+      Pike_error("Bad argument 1 to file->write().\n"
+                 "Element %ld is not a string or buffer object.\n",
+                 (long)i);
+    }
 
-    if (s->size_shift) {
-      free(iovbase);
+    if (shift) {
+      free(iov);
       Pike_error("Bad argument 1 to file->write().\n"
                  "Element %ld is a wide string.\n",
                  (long)i);
     }
 
-    if (s->len) {
-      iov[i].iov_base = s->str;
-      iov[i].iov_len = s->len;
-    } else {
-      iov++;
-      iovcnt--;
+    if ((size_t)skip >= len) {
+      skip -= len;
+      continue;
     }
+    iov[iovcnt].iov_base = (char *)ptr + skip;
+    iov[iovcnt].iov_len = len - skip;
+    skip = 0;
+    iovcnt++;
   }
 
-  for(written = 0; iovcnt; check_signals(0,0,0)) {
+  return iovcnt;
+}
+
+static ptrdiff_t file_write_array(struct my_file *file, struct array *a)
+{
+  ptrdiff_t written, i;
+  int max = a->size;
+  struct iovec *iov = xalloc(sizeof(struct iovec)*max);
+  int e = 0;
+  /* Buffer objects may be modified if the interpreter lock is released. */
+  int threads_allowed = 1;
+
+  /* The iovec is rebuilt on every round, since the buffer objects
+   * (and the array) may have been changed by check_signals() and
+   * check_threads_etc().
+   */
+  for(written = 0; ; check_signals(0,0,0)) {
     int fd = file->box.fd;
-    int cnt = iovcnt;
+    int cnt = file_fill_iovec(a, iov, max, written, &threads_allowed);
 #ifdef HAVE_PIKE_SEND_FD
     int *fd_info = NULL;
     int num_fds = 0;
 #endif
 
+    if (!cnt) break;
+
 #ifdef _REENTRANT
     /* check_signals() may have done something... */
     if (fd < 0) break;
@@ -1937,7 +1979,6 @@ static ptrdiff_t file_write_array(struct my_file *file, struct array *a)
       file->fd_info = NULL;
     }
 #endif
-    THREADS_ALLOW();
 
 #ifdef IOV_MAX
     if (cnt > IOV_MAX) cnt = IOV_MAX;
@@ -1946,16 +1987,29 @@ static ptrdiff_t file_write_array(struct my_file *file, struct array *a)
 #ifdef MAX_IOVEC
     if (cnt > MAX_IOVEC) cnt = MAX_IOVEC;
 #endif
+
+    if (threads_allowed) {
+      THREADS_ALLOW();
 #ifdef HAVE_PIKE_SEND_FD
-    if (fd_info) {
-      i = writev_fds(fd, iov, cnt, fd_info + 2, num_fds);
-    } else
+      if (fd_info) {
+        i = writev_fds(fd, iov, cnt, fd_info + 2, num_fds);
+      } else
 #endif
-      i = writev(fd, iov, cnt);
+        i = writev(fd, iov, cnt);
 
-    if (i < 0) e = errno;
+      if (i < 0) e = errno;
 
-    THREADS_DISALLOW();
+      THREADS_DISALLOW();
+    } else {
+#ifdef HAVE_PIKE_SEND_FD
+      if (fd_info) {
+        i = writev_fds(fd, iov, cnt, fd_info + 2, num_fds);
+      } else
+#endif
+        i = writev(fd, iov, cnt);
+
+      if (i < 0) e = errno;
+    }
 
     /* fprintf(stderr, "writev(%d, 0x%08x, %d) => %d\n",
        fd, (unsigned int)iov, cnt, i); */
@@ -1994,23 +2048,10 @@ static ptrdiff_t file_write_array(struct my_file *file, struct array *a)
       /* Avoid extra writev() */
       if(THIS->open_mode & FILE_NONBLOCKING)
         break;
-
-      while(i) {
-        if ((ptrdiff_t)iov->iov_len <= i) {
-          i -= iov->iov_len;
-          iov++;
-          iovcnt--;
-        } else {
-          /* Use cast since iov_base might be a void pointer */
-          iov->iov_base = ((char *) iov->iov_base) + i;
-          iov->iov_len -= i;
-          i = 0;
-        }
-      }
     }
   }
 
-  free(iovbase);
+  free(iov);
 
   file->my_errno = errno = e;
 
@@ -2202,17 +2243,49 @@ static void file_write(INT32 args)
 #ifdef HAVE_WRITEV
       if (args == 1)
       {
-        if( (a->type_field & ~BIT_STRING) &&
-            (array_fix_type_field(a) & ~BIT_STRING) )
-          SIMPLE_ARG_TYPE_ERROR("write", 1, "string|array(string)");
+        if( (a->type_field & ~(BIT_STRING|BIT_OBJECT)) &&
+            (array_fix_type_field(a) & ~(BIT_STRING|BIT_OBJECT)) )
+          SIMPLE_ARG_TYPE_ERROR("write", 1,
+                                "string|array(string|Stdio.Buffer)");
 
         written = file_write_array(file, a);
         break;
       }
 #endif /* HAVE_WRITEV */
-      ref_push_array(a);
-      push_empty_string();
-      o_multiply();
+      if ((a->type_field & BIT_OBJECT) &&
+          (array_fix_type_field(a) & BIT_OBJECT)) {
+        /* Concatenate by hand, since o_multiply() doesn't handle
+         * buffer objects. */
+        struct string_builder buf;
+        ONERROR uwp;
+        ptrdiff_t i;
+
+        init_string_builder(&buf, 0);
+        SET_ONERROR(uwp, free_string_builder, &buf);
+        for (i = 0; i < a->size; i++) {
+          void *ptr;
+          size_t len;
+          int shift;
+
+          if (TYPEOF(a->item[i]) == PIKE_T_STRING) {
+            string_builder_shared_strcat(&buf, a->item[i].u.string);
+          } else if ((TYPEOF(a->item[i]) == PIKE_T_OBJECT) &&
+                     (get_memory_object_memory(a->item[i].u.object, &ptr,
+                                               &len, &shift) != MEMOBJ_NONE) &&
+                     !shift) {
+            string_builder_binary_strcat(&buf, ptr, len);
+          } else {
+            SIMPLE_ARG_TYPE_ERROR("write", 1,
+                                  "string|array(string|Stdio.Buffer)");
+          }
+        }
+        UNSET_ONERROR(uwp);
+        push_string(finish_string_builder(&buf));
+      } else {
+        ref_push_array(a);
+        push_empty_string();
+        o_multiply();
+      }
       Pike_sp--;
       dmalloc_touch_svalue(Pike_sp);
       Pike_sp[-args] = *Pike_sp;
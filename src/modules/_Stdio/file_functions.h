@@ -22,7 +22,7 @@ FILE_FUNC("peek",file_peek, tFunc(tOr3(tFlt,tInt,tVoid) tOr(tInt,tVoid), tInt))
 FILE_FUNC("write",file_write,
 	  tOr4(tFunc(tStr, tInt),
                tFuncV(tObj, tOr(tInt, tVoid), tInt),
-	       tFuncV(tArr(tStr), tMixed, tInt),
+	       tFuncV(tArr(tOr(tStr, tObj)), tMixed, tInt),
 	       tFuncV(tAttr("sprintf_format", tStr),
 		      tAttr("sprintf_args", tMixed),tInt)))
 /* function(int|void,int|void:string) */
@@ -1347,7 +1347,8 @@ struct memloc
 #define MEM_TRACE			64
 #define MEM_SCANNED			128
 
-static struct block_allocator memloc_allocator = BA_INIT_PAGES(sizeof(struct memloc), 64);
+/* Used under debug_malloc_mutex, not the interpreter lock. */
+static struct block_allocator memloc_allocator = BA_INIT_UNLOCKED(sizeof(struct memloc), 64);
 
 static struct memloc * alloc_memloc() {
     return ba_alloc(&memloc_allocator);
@@ -3015,7 +3016,7 @@ struct memory_map_entry
   struct memory_map *recur;
 };
 
-static struct block_allocator memory_map_allocator = BA_INIT_PAGES(sizeof(struct memory_map), 8);
+static struct block_allocator memory_map_allocator = BA_INIT_UNLOCKED(sizeof(struct memory_map), 8);
 
 static struct memory_map * alloc_memory_map() {
     return ba_alloc(&memory_map_allocator);
@@ -3026,7 +3027,7 @@ void count_memory_in_memory_maps(size_t * n, size_t * s) {
 }
 
 static struct block_allocator memory_map_entry_allocator
-    = BA_INIT_PAGES(sizeof(struct memory_map_entry), 16);
+    = BA_INIT_UNLOCKED(sizeof(struct memory_map_entry), 16);
 
 static struct memory_map_entry * alloc_memory_map_entry() {
     return ba_alloc(&memory_map_entry_allocator);
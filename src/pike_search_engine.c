@@ -58,6 +58,9 @@ INTERMEDIATE(memchr_memcmp5)
 INTERMEDIATE(memchr_memcmp6)
 INTERMEDIATE(boyer_moore_hubbe)
 INTERMEDIATE(hubbe_search)
+#if defined(HAVE_MEMMEM) && NSHIFT == 0
+INTERMEDIATE(memmem_search)
+#endif
 
 
 /* */
@@ -217,6 +220,20 @@ void NameN(init_memsearch)(
   ptrdiff_t needlelen,
   ptrdiff_t max_haystacklen)
 {
+#if defined(HAVE_MEMMEM) && NSHIFT == 0
+  if(needlelen >= 7)
+  {
+    /* memmem() beats both hubbe_search and boyer_moore_hubbe on 8-bit
+     * haystacks, so don't build any tables up front. */
+    s->data.bm.needle=needle;
+    s->data.bm.needlelen=needlelen;
+    s->data.bm.plen=0;
+    s->mojt.vtab=& PxC3(memmem_search,NSHIFT,_vtable);
+    s->mojt.data=(void *)& s->data.bm;
+    return;
+  }
+#endif
+
   switch(needlelen)
   {
     case 0:
@@ -54,20 +54,28 @@ inline HCHAR *NameNH(memchr_memcmp)(NCHAR *needle,
 				    HCHAR *haystack,
 				    ptrdiff_t haystacklen)
 {
-  NCHAR c;
-  HCHAR *end;
-
   if(needlelen > haystacklen) return 0;
 
-  end=haystack + haystacklen - needlelen+1;
-  c=needle[0];
-  needle++;
-  needlelen--;
-  while((haystack=NameNH(MEMCHR)(haystack,c,end-haystack)))
-    if(!NameNH(MEMCMP)(needle,++haystack,needlelen))
-      return haystack-1;
-
-  return 0;
+#if defined(HAVE_MEMMEM) && NSHIFT == 0 && HSHIFT == 0
+  /* The libc version is vectorized, and does not stop at every
+   * occurrence of the first character. */
+  return memmem(haystack, haystacklen, needle, needlelen);
+#else
+  {
+    NCHAR c;
+    HCHAR *end;
+
+    end=haystack + haystacklen - needlelen+1;
+    c=needle[0];
+    needle++;
+    needlelen--;
+    while((haystack=NameNH(MEMCHR)(haystack,c,end-haystack)))
+      if(!NameNH(MEMCMP)(needle,++haystack,needlelen))
+	return haystack-1;
+
+    return 0;
+  }
+#endif
 }
 
 
@@ -100,6 +108,7 @@ HCHAR *NameNH(boyer_moore_hubbe)(struct boyer_moore_hubbe_searcher *s,
 
   ptrdiff_t i=plen-1;
   ptrdiff_t hlen=haystacklen;
+
   if(nlen > plen)
     hlen -= nlen-plen;
 
@@ -155,6 +164,31 @@ HCHAR *NameNH(boyer_moore_hubbe)(struct boyer_moore_hubbe_searcher *s,
   return 0;
 }
 
+#if defined(HAVE_MEMMEM) && NSHIFT == 0
+void NameN(init_boyer_moore_hubbe)(struct boyer_moore_hubbe_searcher *s,
+				   NCHAR *needle,
+				   ptrdiff_t needlelen,
+				   ptrdiff_t max_haystacklen);
+
+/* Used for needles of 7 characters or more, see init_memsearch().
+ * The boyer-moore-hubbe tables are only needed for wide haystacks,
+ * and are built on first use (s->plen is zero until then).
+ */
+HCHAR *NameNH(memmem_search)(struct boyer_moore_hubbe_searcher *s,
+			     HCHAR *haystack,
+			     ptrdiff_t haystacklen)
+{
+#if HSHIFT == 0
+  if(NEEDLELEN > haystacklen) return 0;
+  return memmem(haystack, haystacklen, NEEDLE, NEEDLELEN);
+#else
+  if(!s->plen)
+    NameN(init_boyer_moore_hubbe)(s, NEEDLE, NEEDLELEN, 0x7fffffff);
+  return NameNH(boyer_moore_hubbe)(s, haystack, haystacklen);
+#endif
+}
+#endif /* HAVE_MEMMEM && NSHIFT == 0 */
+
 
 HCHAR *NameNH(hubbe_search)(struct hubbe_searcher *s,
 			    HCHAR *haystack,
@@ -13,7 +13,14 @@
 #include "fdlib.h"
 #include "fd_control.h"
 
+#include "config.h"
+
 #include <sys/stat.h>
+#include <errno.h>
+
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 
 #include "shuffler.h"
 
@@ -54,6 +61,47 @@ static struct data get_data( struct source *src, off_t len )
   return res;
 }
 
+#if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+/* Let the kernel copy the file to the destination with sendfile(2). */
+static int send_to( struct source *src, int fd, int len )
+{
+  struct fd_source *s = (struct fd_source *)src;
+  ptrdiff_t rr;
+  int e = 0;
+
+  if (s->len > 0 && len > s->len)
+    len = s->len;
+
+  THREADS_ALLOW();
+  while(0 > (rr = sendfile(fd, s->fd, NULL, len)) && errno == EINTR);
+  if (rr < 0) e = errno;
+  THREADS_DISALLOW();
+
+  if (rr < 0)
+  {
+    switch(e)
+    {
+    case EWOULDBLOCK:
+#if defined(EAGAIN) && (EAGAIN != EWOULDBLOCK)
+    case EAGAIN:
+#endif
+      return -2;
+    }
+    /* Either sendfile() does not support this pair of fds (EINVAL,
+     * ENOSYS), or reading or writing failed and it is not known which.
+     * Let get_data() and the ordinary write path redo the transfer,
+     * so that errors are reported as read or write errors.
+     */
+    src->send_to = NULL;
+    return -3;
+  }
+
+  if (!rr || (s->len > 0 && !(s->len -= rr)))
+    s->s.eof = 1;
+  return rr;
+}
+#endif /* HAVE_SENDFILE && HAVE_SYS_SENDFILE_H */
+
 
 static void free_source( struct source *src )
 {
@@ -101,6 +149,9 @@ struct source *source_normal_file_make( struct svalue *s,
   res->fd = fd;
   res->s.get_data = get_data;
   res->s.free_source = free_source;
+#if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+  res->s.send_to = send_to;
+#endif
   res->obj = s->u.object;
   add_ref(res->obj);
   res->len = len;
@@ -27,6 +27,14 @@ struct source
   void (*setup_callbacks)(struct source *s);
   void (*remove_callbacks)(struct source *s);
 
+  /* Optional. Sends up to len bytes directly to the fd without
+   * passing them through get_data. Returns the number of bytes
+   * sent (0 and eof set at end of data), -2 if the fd would block,
+   * and -3 on errors or if it can not be used for this fd, in which
+   * case get_data is used instead.
+   */
+  int (*send_to)(struct source *s, int fd, int len);
+
   /* The following is only used by nonblocking sources. A nonblocking
    * source is defined as a source that returns a data struct from
    * get_data with a 'len' value of -2.
@@ -1942,6 +1942,76 @@ static void free_f_sprintf_data (struct format_stack *fs)
   free (fs->format_info_stack);
 }
 
+/* Fast path for the common case of a format string that only
+ * contains plain %s, %d, %x, %O and %% directives (ie no flags,
+ * widths or modifiers), and where the corresponding arguments
+ * are strings and native integers respectively.
+ *
+ * Returns 0 without touching r if the format string or the
+ * arguments are not simple enough, in which case the caller
+ * should use low_pike_sprintf().
+ */
+static int simple_sprintf(struct string_builder *r,
+			  struct pike_string *format,
+			  struct svalue *argp,
+			  ptrdiff_t num_arg)
+{
+  PCHARP fmt = MKPCHARP_STR(format);
+  ptrdiff_t e, start, argument = 0;
+
+  for (e = 0; e < format->len; e++) {
+    if (INDEX_PCHARP(fmt, e) != '%') continue;
+    if (++e == format->len) return 0;
+    switch (INDEX_PCHARP(fmt, e)) {
+    case '%':
+      break;
+    case 's':
+      if ((argument >= num_arg) || (TYPEOF(argp[argument]) != T_STRING))
+	return 0;
+      argument++;
+      break;
+    case 'd':
+    case 'x':
+    case 'O':
+      if ((argument >= num_arg) || (TYPEOF(argp[argument]) != T_INT))
+	return 0;
+      argument++;
+      break;
+    default:
+      return 0;
+    }
+  }
+
+  argument = 0;
+  for (e = start = 0; e < format->len; e++) {
+    if (INDEX_PCHARP(fmt, e) != '%') continue;
+    if (e > start)
+      string_builder_append(r, ADD_PCHARP(fmt, start), e - start);
+    switch (INDEX_PCHARP(fmt, ++e)) {
+    case '%':
+      string_builder_putchar(r, '%');
+      break;
+    case 's':
+      string_builder_shared_strcat(r, argp[argument++].u.string);
+      break;
+    case 'd':
+    case 'O':
+      string_builder_append_integer(r, argp[argument++].u.integer,
+				    10, APPEND_SIGNED, 0, 0);
+      break;
+    case 'x':
+      string_builder_append_integer(r, argp[argument++].u.integer,
+				    16, APPEND_SIGNED, 0, 0);
+      break;
+    }
+    start = e + 1;
+  }
+  if (e > start)
+    string_builder_append(r, ADD_PCHARP(fmt, start), e - start);
+
+  return 1;
+}
+
 /* The efun */
 void low_f_sprintf(INT32 args, struct string_builder *r)
 {
@@ -1970,6 +2040,8 @@ void low_f_sprintf(INT32 args, struct string_builder *r)
     }
   }
 
+  if (simple_sprintf(r, argp->u.string, argp+1, args-1)) return;
+
   fs.size = round_up32(args*2);
   stack_alloc_init(&fs.a, 128); /* this should scale with fs.size */
   fs.format_info_stack = xalloc(fs.size*sizeof(struct format_info));
@@ -2461,6 +2533,16 @@ static node *optimize_sprintf(node *n)
           break;
         }
         return ret;
+
+      case 'd':
+	if (pike_types_le((*arg1)->type, int_type_string)) {
+	  /* (string) formats integers (including bignums) the same way. */
+	  ADD_NODE_REF2(*arg1,
+			ret = mkcastnode(string_type_string, *arg1);
+	    );
+	}
+	return ret;
+
       case '%':
 	{
 	  /* FIXME: This code can be removed when the generic
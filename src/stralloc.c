@@ -55,6 +55,29 @@ static struct pike_string **base_table=0;
 static unsigned INT32 num_strings=0;
 PMOD_EXPORT struct pike_string *empty_pike_string = 0;
 
+/* When the hash table grows, the strings are moved from the old
+ * table to the new one a few buckets at a time (see
+ * stralloc_rehash_step()), to avoid a long pause when the table is
+ * large. While that is in progress old_base_table is non-NULL, and
+ * the buckets in it below old_rehash_pos have already been moved.
+ *
+ * Code that needs to traverse the entire table should call
+ * stralloc_finish_rehash() first.
+ */
+#define OLD_HMODULO(X) ((X) & (old_htable_size - 1))
+#define STRALLOC_REHASH_STEP	4
+
+static unsigned INT32 old_htable_size=0;
+static unsigned INT32 old_rehash_pos=0;
+static struct pike_string **old_base_table=0;
+
+static void stralloc_finish_rehash(void);
+
+/* Lookup statistics, reported by String.status(). */
+static UINT64 num_str_searches=0;
+static UINT64 search_len=0;
+static unsigned INT32 max_search_len=0;
+
 /*** Main string hash function ***/
 
 #define StrHash(s,len) low_do_hash(s,len,0)
@@ -349,6 +372,8 @@ static void locate_problem(int (*isproblem)(const struct pike_string *))
   DM(struct memhdr *yes=alloc_memhdr());
   DM(struct memhdr *no=alloc_memhdr());
 
+  stralloc_finish_rehash();
+
   for(e=0;e<htable_size;e++)
   {
     for(s=base_table[e];s;s=s->next)
@@ -404,31 +429,46 @@ static struct pike_string *internal_findstring(const char *s,
   unsigned int depth=0;
   unsigned int prefix_depth=0;
 
-  size_t h;
-  h=HMODULO(hval);
-  for(curr = base_table[h]; curr; curr = curr->next)
-  {
-#ifdef PIKE_DEBUG
-    if(curr->refs<1)
+  int old_table = 0;
+
+  curr = base_table[HMODULO(hval)];
+  while (1) {
+    for(; curr; curr = curr->next)
     {
-      debug_dump_pike_string(curr, 70);
-      locate_problem(has_zero_refs);
-      Pike_fatal("String with no references.\n");
-    }
+#ifdef PIKE_DEBUG
+      if(curr->refs<1)
+      {
+        debug_dump_pike_string(curr, 70);
+        locate_problem(has_zero_refs);
+        Pike_fatal("String with no references.\n");
+      }
 #endif
-    debug_malloc_touch(curr);
+      debug_malloc_touch(curr);
 
-    if ( len == curr->len &&
-        size_shift == curr->size_shift &&
-         hval == curr->hval &&
-        ( curr->str == s ||
-          !memcmp(curr->str, s,len<<size_shift))) /* found it */
-      return curr;
+      if ( len == curr->len &&
+          size_shift == curr->size_shift &&
+           hval == curr->hval &&
+          ( curr->str == s ||
+            !memcmp(curr->str, s,len<<size_shift))) /* found it */
+        break;
 
-    depth++;
-    if (curr->len > (ptrdiff_t)hash_prefix_len)
-      prefix_depth++;
+      depth++;
+      if (curr->len > (ptrdiff_t)hash_prefix_len)
+        prefix_depth++;
+    }
+    if (curr || old_table || !old_base_table) break;
+    /* A rehash is in progress, and the string may still be in the
+     * old table. Buckets that already have been moved are empty.
+     */
+    old_table = 1;
+    curr = old_base_table[OLD_HMODULO(hval)];
   }
+
+  num_str_searches++;
+  search_len += depth;
+  if (depth > max_search_len) max_search_len = depth;
+  if (curr) return curr;
+
   if (depth > need_new_hashkey_depth) {
     /* Keep track of whether the hashtable is getting unbalanced. */
     need_new_hashkey_depth = depth;
@@ -489,25 +529,42 @@ static void rehash_string_backwards(struct pike_string *s)
   } while ((s = next));
 }
 
+/* Move up to n buckets from the old hash table to the new one. */
+static void stralloc_rehash_step(unsigned INT32 n)
+{
+  while (n-- && (old_rehash_pos < old_htable_size)) {
+    rehash_string_backwards(old_base_table[old_rehash_pos]);
+    old_base_table[old_rehash_pos++] = NULL;
+  }
+
+  if (old_rehash_pos >= old_htable_size) {
+    free(old_base_table);
+    old_base_table = NULL;
+    old_htable_size = old_rehash_pos = 0;
+  }
+}
+
+static void stralloc_finish_rehash(void)
+{
+  if (old_base_table) stralloc_rehash_step(old_htable_size);
+}
+
 static void stralloc_rehash(void)
 {
-  int h,old;
-  struct pike_string **old_base;
+  /* Should normally have finished long ago, since the table has
+   * doubled in size since the last time.
+   */
+  stralloc_finish_rehash();
 
-  old=htable_size;
-  old_base=base_table;
+  old_htable_size=htable_size;
+  old_base_table=base_table;
+  old_rehash_pos=0;
 
   SET_HSIZE(htable_size<<1);
 
   base_table=xcalloc(sizeof(struct pike_string *), htable_size);
 
   need_more_hash_prefix_depth = 0;
-
-  for(h=0;h<old;h++)
-    rehash_string_backwards(old_base[h]);
-
-  if(old_base)
-    free(old_base);
 }
 
 /* Allocation of strings */
@@ -581,6 +638,10 @@ static void link_pike_string(struct pike_string *s, size_t hval)
   s->flags &= ~(STRING_NOT_HASHED|STRING_NOT_SHARED);
   num_strings++;
 
+  if (old_base_table) {
+    stralloc_rehash_step(STRALLOC_REHASH_STEP);
+  }
+
   if(num_strings > htable_size) {
     stralloc_rehash();
   }
@@ -623,6 +684,8 @@ static void link_pike_string(struct pike_string *s, size_t hval)
      */
     need_more_hash_prefix_depth=0;
 
+    stralloc_finish_rehash();
+
     for(h=0;h<htable_size;h++)
     {
       struct pike_string *tmp=base_table[h];
@@ -1018,26 +1081,26 @@ PMOD_EXPORT struct pike_string *debug_make_shared_string2(const p_wchar2 *str)
 
 /*** Free strings ***/
 
-void unlink_pike_string(struct pike_string *s)
+static int unlink_from_bucket(struct pike_string **prev,
+			      struct pike_string *s)
 {
-  size_t h=HMODULO(s->hval);
-  struct pike_string *tmp=base_table[h], *p=NULL;
+  struct pike_string *tmp;
 
-  while( tmp )
-  {
-    if( tmp == s )
-    {
-      if( p )
-        p->next = s->next;
-      else
-        base_table[h] = s->next;
-      break;
+  while ((tmp = *prev)) {
+    if (tmp == s) {
+      *prev = s->next;
+      return 1;
     }
-    p = tmp;
-    tmp = tmp->next;
+    prev = &tmp->next;
   }
+  return 0;
+}
 
-  if( !tmp )
+void unlink_pike_string(struct pike_string *s)
+{
+  if (!unlink_from_bucket(base_table + HMODULO(s->hval), s) &&
+      (!old_base_table ||
+       !unlink_from_bucket(old_base_table + OLD_HMODULO(s->hval), s)))
     Pike_fatal("unlink on non-shared string\n");
 
   s->next=(struct pike_string *)(ptrdiff_t)-1;
@@ -1115,13 +1178,18 @@ struct pike_string *add_string_status(int verbose)
     long num_distinct_strings[8] = {0,0,0,0,0,0,0,0};
     long bytes_distinct_strings[8] = {0,0,0,0,0,0,0,0};
     long overhead_bytes[8] = {0,0,0,0,0,0,0,0};
-    unsigned INT32 e;
+    unsigned INT32 e, used = 0, longest = 0;
     struct pike_string *p;
+
+    stralloc_finish_rehash();
+
     for(e=0;e<htable_size;e++)
     {
+      unsigned INT32 chain = 0;
       for(p=base_table[e];p;p=p->next)
       {
 	int key = p->size_shift + (string_is_malloced(p)?4:0);
+        chain++;
        num_distinct_strings[key]++;
         alloced_bytes[key] += p->refs*sizeof(struct pike_string);
        alloced_strings[key] += p->refs;
@@ -1133,6 +1201,8 @@ struct pike_string *add_string_status(int verbose)
             p->refs*DO_ALIGN((p->len+3) << p->size_shift,sizeof(void *));
         }
       }
+      if (chain) used++;
+      if (chain > longest) longest = chain;
     }
     string_builder_sprintf(&s,
                           "\nShared string hash table:\n"
@@ -1199,12 +1269,22 @@ struct pike_string *add_string_status(int verbose)
     } else {
       string_builder_strcat(&s, "   -\n");
     }
+
+    string_builder_sprintf(&s,
+                          "\nHash table size: %d  Strings: %d  "
+                          "Used buckets: %d  Longest chain: %d\n",
+                          htable_size, num_strings, used, longest);
+    string_builder_sprintf(&s,
+                          "Searches: %ld  Average search length: %d.%02d  "
+                          "Max search length: %d\n",
+                          (long)num_str_searches,
+                          (int)(num_str_searches?
+                                search_len / num_str_searches : 0),
+                          (int)(num_str_searches?
+                                (search_len * 100 / num_str_searches) % 100 :
+                                0),
+                          max_search_len);
   }
-/*
-  sprintf(b,"Searches: %ld    Average search length: %6.3f\n",
-      (long)num_str_searches, (double)search_len / num_str_searches);
-  my_strcat(b);
-*/
   return finish_string_builder(&s);
 }
 
@@ -1270,6 +1350,8 @@ PMOD_EXPORT void verify_shared_strings_tables(void)
 
   last_stralloc_verify=current_do_debug_cycle;
 
+  stralloc_finish_rehash();
+
   for(e=0;e<htable_size;e++)
   {
     h=0;
@@ -1342,6 +1424,16 @@ const struct pike_string *debug_findstring(const struct pike_string *s)
       return s;
     }
   }
+  if (old_base_table) {
+    h = OLD_HMODULO(s->hval);
+    for(p=old_base_table[h];p;p=p->next)
+    {
+      if(p==s)
+      {
+        return s;
+      }
+    }
+  }
   return NULL;
 }
 
@@ -1349,6 +1441,7 @@ int safe_debug_findstring(const struct pike_string *foo)
 {
   unsigned INT32 e;
   if(!base_table) return 0;
+  stralloc_finish_rehash();
   for(e=0;e<htable_size;e++)
   {
     struct pike_string *p;
@@ -1405,6 +1498,7 @@ void dump_stralloc_strings(void)
 {
   unsigned INT32 e;
   struct pike_string *p;
+  stralloc_finish_rehash();
   for(e=0;e<htable_size;e++)
   {
     for(p=base_table[e];p;p=p->next) {
@@ -2137,6 +2231,8 @@ void cleanup_shared_string_table(void)
   }
 #endif
 
+  stralloc_finish_rehash();
+
   for(e=0;e<htable_size;e++)
   {
     for(s=base_table[e];s;s=next)
@@ -2159,6 +2255,8 @@ void count_string_types() {
   unsigned INT32 e;
   size_t num_static = 0, num_short = 0, num_substring = 0, num_malloc = 0;
 
+  stralloc_finish_rehash();
+
   for (e = 0; e < htable_size; e++) {
       struct pike_string * s;
 
@@ -2215,6 +2313,8 @@ void count_memory_in_strings(size_t *num, size_t *_size)
   size_t size = 0;
   *num = num_strings;
 
+  stralloc_finish_rehash();
+
   size+=htable_size * sizeof(struct pike_string *);
 
   for (e = 0; e < htable_size; e++) {
@@ -2252,6 +2352,7 @@ unsigned gc_touch_all_strings(void)
   unsigned INT32 e;
   unsigned n = 0;
   if (!base_table) return 0;
+  stralloc_finish_rehash();
   for(e=0;e<htable_size;e++)
   {
     struct pike_string *p;
@@ -2264,6 +2365,7 @@ void gc_mark_all_strings(void)
 {
   unsigned INT32 e;
   if(!base_table) return;
+  stralloc_finish_rehash();
   for(e=0;e<htable_size;e++)
   {
     struct pike_string *p;
@@ -2274,7 +2376,9 @@ void gc_mark_all_strings(void)
 
 PMOD_EXPORT struct pike_string *next_pike_string (const struct pike_string *s)
 {
-  struct pike_string *next = s->next;
+  struct pike_string *next;
+  stralloc_finish_rehash();
+  next = s->next;
   if (!next) {
     size_t h = s->hval;
     do {